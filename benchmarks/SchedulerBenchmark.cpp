@@ -0,0 +1,182 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "CronScheduler.h"
+#include "RingExecutor.h"
+
+using namespace cron;
+
+namespace
+{
+
+const unsigned kOneShotTasks = 100000;
+const unsigned kRepeatableTasks = 1000;
+const unsigned kTicks = 1000;
+const unsigned kSharedEvents = 10000;
+
+std::atomic<unsigned> executedTasks(0);
+
+void countTask(const ContextCPtr& ctx, const CancellationTokenCPtr& token)
+{
+    executedTasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+using Clock = std::chrono::steady_clock;
+
+using InlineScheduler = BasicCronScheduler<MultisetTimerStore, InlineExecutor, ExternalClock,
+    IScheduler::CancellableCallback>;
+using EmbeddedScheduler = BasicCronScheduler<HeapTimerStore, InlineExecutor, UnsyncExternalClock,
+    void(*)(const ContextCPtr&, const CancellationTokenCPtr&)>;
+
+struct timeval toTimeval(time_t timestampMs)
+{
+    struct timeval tval;
+    tval.tv_sec = timestampMs / 1000;
+    tval.tv_usec = (timestampMs % 1000) * 1000;
+    return tval;
+}
+
+void report(const char* name, const char* scenario, Clock::duration elapsed, unsigned runs)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    std::cout << name << " / " << scenario << ": " << runs << " runs, "
+        << static_cast<double>(ns) / runs << " ns per run" << std::endl;
+}
+
+// all tasks expire on a single time update
+template<class Scheduler>
+void benchmarkOneShot(const char* name, Scheduler& scheduler, bool inlined = false)
+{
+    const time_t start = 1000000;
+    scheduler.onNewTime(toTimeval(start));
+    for (unsigned i = 0; i < kOneShotTasks; i++)
+        scheduler.scheduleAt(toTimeval(start + 1), &countTask, false, nullptr, std::chrono::milliseconds(0), inlined);
+
+    executedTasks = 0;
+    auto begin = Clock::now();
+    scheduler.onNewTime(toTimeval(start + 1));
+    while (executedTasks < kOneShotTasks)
+        std::this_thread::yield();
+    report(name, "one-shot", Clock::now() - begin, kOneShotTasks);
+}
+
+// repeatable tasks are rescheduled on every time update
+template<class Scheduler>
+void benchmarkRepeatable(const char* name, Scheduler& scheduler)
+{
+    const time_t start = 2000000;
+    scheduler.onNewTime(toTimeval(start));
+    for (unsigned i = 0; i < kRepeatableTasks; i++)
+        scheduler.repeatEvery(std::chrono::milliseconds(1), &countTask, nullptr, std::chrono::milliseconds(0));
+
+    executedTasks = 0;
+    auto begin = Clock::now();
+    for (unsigned tick = 1; tick <= kTicks; tick++)
+        scheduler.onNewTime(toTimeval(start + tick));
+    report(name, "repeatable", Clock::now() - begin, executedTasks);
+}
+
+// CronScheduler is never destroyed as its dispatcher loop holds it, so every scenario
+// runs in its own process to keep spinning dispatchers away from the following ones
+template<class Scenario>
+void runIsolated(Scenario&& scenario)
+{
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0)
+    {
+        scenario();
+        std::cout.flush();
+        _exit(0);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+}
+
+// fire events are consumed by a forked process which reports the delivery latency
+void benchmarkSharedRing()
+{
+    const std::string ringName = "/cron_scheduler_benchmark_" + std::to_string(getpid());
+    SharedCronScheduler scheduler(ringName, 1024);
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        SharedEventReader reader(ringName);
+        int64_t totalNs = 0;
+        unsigned received = 0;
+        SharedEvent event;
+        while (received < kSharedEvents && reader.wait(event, std::chrono::milliseconds(1000)))
+        {
+            totalNs += SharedEventRing::monotonicNs() - event.publishedNs;
+            received++;
+        }
+        std::cout << "shared ring / consumer process: " << received << " events, "
+            << (received ? totalNs / received : 0) << " ns average latency, "
+            << reader.getLostAmount() << " lost" << std::endl;
+        _exit(0);
+    }
+
+    while (scheduler.getExecutor().getConsumersAmount() == 0)
+        std::this_thread::yield();
+
+    const time_t start = 3000000;
+    scheduler.onNewTime(toTimeval(start));
+    for (unsigned i = 1; i <= kSharedEvents; i++)
+    {
+        scheduler.scheduleAt(toTimeval(start + i), nullptr, false, nullptr, std::chrono::milliseconds(0));
+        scheduler.onNewTime(toTimeval(start + i));
+        // gives the consumer a chance to sleep on the futex between the events
+        if (i % 100 == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+}
+
+} // namespace
+
+int main()
+{
+    runIsolated([] {
+        std::shared_ptr<CronScheduler> scheduler(new CronScheduler(4));
+        scheduler->initialize();
+        benchmarkOneShot("pool executor, multiset, std::function", *scheduler);
+    });
+    runIsolated([] {
+        std::shared_ptr<CronScheduler> scheduler(new CronScheduler(4));
+        scheduler->initialize();
+        // budget covers the whole pass to show the cost of the inline path itself
+        scheduler->setInlineBudget(std::chrono::seconds(1));
+        benchmarkOneShot("pool executor, inline tasks", *scheduler, true);
+    });
+
+    runIsolated([] {
+        InlineScheduler scheduler;
+        benchmarkOneShot("inline executor, multiset, std::function", scheduler);
+    });
+    runIsolated([] {
+        InlineScheduler scheduler;
+        benchmarkRepeatable("inline executor, multiset, std::function", scheduler);
+    });
+
+    runIsolated([] {
+        EmbeddedScheduler scheduler;
+        benchmarkOneShot("inline executor, heap, function pointer", scheduler);
+    });
+    runIsolated([] {
+        EmbeddedScheduler scheduler;
+        benchmarkRepeatable("inline executor, heap, function pointer", scheduler);
+    });
+
+    runIsolated(benchmarkSharedRing);
+
+    return 0;
+}
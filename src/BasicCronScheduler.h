@@ -0,0 +1,385 @@
+#ifndef BASICCRONSCHEDULER_H_
+#define BASICCRONSCHEDULER_H_
+
+#include <sys/time.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Context.h"
+#include "CronTask.h"
+#include "IScheduler.h"
+#include "SchedulerPolicies.h"
+#include "TraceRecorder.h"
+
+namespace cron
+{
+
+// base of the schedulers whose callback type differs from the IScheduler one,
+// their calls are resolved statically and could be inlined
+struct StaticScheduler
+{};
+
+// TimerStore<Task> keeps the pending tasks and defines the Mutex guarding them,
+// Executor runs expired tasks either inline (synchronous) or on its own threads,
+// Clock stores the time passed to onNewTime(), TaskCallback is stored in every task.
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+class BasicCronScheduler :
+    public std::enable_shared_from_this<BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>>,
+    public std::conditional<std::is_same<TaskCallback, IScheduler::CancellableCallback>::value,
+        IScheduler, StaticScheduler>::type
+{
+public:
+    using CronIdentifier = IScheduler::CronIdentifier;
+    using Callback = IScheduler::Callback;
+    using CancellableCallback = TaskCallback;
+    using Task = BasicCronTask<TaskCallback>;
+    using TaskContainer = TimerStore<Task>;
+    using Mutex = typename TaskContainer::Mutex;
+
+public:
+    // arguments are passed to the executor
+    template<class... ExecutorArgs>
+    explicit BasicCronScheduler(ExecutorArgs&&... args);
+    BasicCronScheduler(const BasicCronScheduler&) = delete;
+    BasicCronScheduler& operator= (const BasicCronScheduler&) = delete;
+    ~BasicCronScheduler();
+
+public:
+    static time_t getTimestampInMs(const struct timeval& param);
+
+public:
+    // synchronous executors run expired tasks here holding the store lock,
+    // so their callbacks may call back into the scheduler only with a NullMutex store
+    void onNewTime(const struct  timeval& param);
+    void cancelTask(CronIdentifier key);
+    void initialize();
+
+    CronIdentifier scheduleAt(const struct timeval& tval , Callback&& callback);
+    CronIdentifier scheduleAt(const struct timeval& tval, Callback&& callback,
+        bool repeatable);
+    CronIdentifier scheduleAt(const struct timeval& tval, Callback&& callback,
+        bool repeatable, const ContextCPtr& ctxCPtr);
+    CronIdentifier scheduleAt(const struct timeval& tval, CancellableCallback&& callback,
+        bool repeatable, const ContextCPtr& ctxCPtr, std::chrono::milliseconds deadline);
+    // PoolExecutor runs inline tasks on the dispatcher thread within its inline budget,
+    // their deadlines are not watched
+    CronIdentifier scheduleAt(const struct timeval& tval, CancellableCallback&& callback,
+        bool repeatable, const ContextCPtr& ctxCPtr, std::chrono::milliseconds deadline, bool inlined);
+
+    template<class Rep, class Period>
+    CronIdentifier repeatEvery(const std::chrono::duration<Rep, Period>& interval, Callback&& callback)
+    {
+        return repeatEvery(interval, std::move(callback), nullptr);
+    }
+
+    template<class Rep, class Period>
+    CronIdentifier repeatEvery(const std::chrono::duration<Rep, Period>& interval,
+        Callback&& callback, const ContextCPtr& ctx)
+    {
+        time_t intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(interval).count();
+        std::lock_guard<Mutex> locker(lock_);
+        time_t current = clock_.now();
+        std::shared_ptr<Task> task = std::make_shared<Task>(
+            current + intervalMs, current, std::move(callback), true, lastTaskId_++, ctx);
+        addTask(std::move(task));
+        return lastTaskId_ - 1;
+    }
+
+    template<class Rep, class Period>
+    CronIdentifier repeatEvery(const std::chrono::duration<Rep, Period>& interval,
+        CancellableCallback&& callback, const ContextCPtr& ctx, std::chrono::milliseconds deadline)
+    {
+        return repeatEvery(interval, std::move(callback), ctx, deadline, false);
+    }
+
+    template<class Rep, class Period>
+    CronIdentifier repeatEvery(const std::chrono::duration<Rep, Period>& interval,
+        CancellableCallback&& callback, const ContextCPtr& ctx, std::chrono::milliseconds deadline,
+        bool inlined)
+    {
+        time_t intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(interval).count();
+        std::lock_guard<Mutex> locker(lock_);
+        time_t current = clock_.now();
+        std::shared_ptr<Task> task = std::make_shared<Task>(current + intervalMs,
+            current, std::move(callback), true, lastTaskId_++, ctx, deadline.count(), inlined);
+        addTask(std::move(task));
+        return lastTaskId_ - 1;
+    }
+
+    // available with PoolExecutor only
+    template<class Handler>
+    void setOverrunHandler(Handler&& handler)
+    {
+        executor_.setOverrunHandler(std::forward<Handler>(handler));
+    }
+
+    unsigned getOverrunsAmount() const
+    {
+        return executor_.getOverrunsAmount();
+    }
+
+    auto getPoolStatistics() const
+    {
+        return executor_.getPoolStatistics();
+    }
+
+    template<class Rep, class Period>
+    void setInlineBudget(const std::chrono::duration<Rep, Period>& budget)
+    {
+        executor_.setInlineBudget(budget);
+    }
+
+    const Executor& getExecutor() const
+    {
+        return executor_;
+    }
+
+    // nullptr disables tracing
+    void setTraceRecorder(const TraceRecorderPtr& tracer);
+
+private:
+    void initialize(std::true_type synchronous);
+    void initialize(std::false_type synchronous);
+    void addTask(std::shared_ptr<Task>&& task);
+    void proceedTasks();
+
+private:
+    bool finished_;
+    bool updated_;
+    std::atomic<unsigned> lastTaskId_;
+    std::condition_variable condition_;
+    Mutex lock_;
+    TaskContainer tasks_;
+    // reused between the passes to keep the expiry path free of allocations
+    std::vector<std::shared_ptr<Task>> tasksToRepeat_;
+    Clock clock_;
+    TraceRecorderPtr tracer_;
+    // declared last: its threads must be joined before the members above are destroyed
+    Executor executor_;
+};
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+template<class... ExecutorArgs>
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::BasicCronScheduler(ExecutorArgs&&... args) :
+    finished_(false),
+    updated_(false),
+    lastTaskId_(0),
+    executor_(std::forward<ExecutorArgs>(args)...)
+{ }
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::~BasicCronScheduler()
+{
+    std::lock_guard<Mutex> locker(lock_);
+    finished_ = true;
+    updated_ = true;
+    condition_.notify_one();
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::initialize()
+{
+    initialize(std::integral_constant<bool, Executor::synchronous>());
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::initialize(std::true_type)
+{
+    // tasks are proceeded by onNewTime(), there is no dispatcher loop
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::initialize(std::false_type)
+{
+    static_assert(std::is_same<Mutex, std::mutex>::value,
+        "asynchronous executor requires a timer store guarded by std::mutex");
+
+    // to avoid segfault when object destructed but worker thread access it
+    auto self(this->shared_from_this());
+    executor_.start([self, this] {
+        while(!finished_)
+        {
+            if (this->tasks_.empty())
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::unique_lock<std::mutex> locker(lock_);
+                updated_ = false;
+
+                // to avoid a race condition if  task was removed in the meantime
+                if (this->tasks_.empty())
+                    continue;
+
+                time_t planned = tasks_.top()->planned();
+                time_t current = clock_.now();
+                if (planned > current)
+                {
+                    this->condition_.wait_for(locker,
+                        std::chrono::milliseconds(planned - current),
+                        [this, planned]
+                            { return updated_ || clock_.now() >= planned; }
+                    );
+                }
+
+                proceedTasks();
+
+                // inline tasks run without the lock so they may call back into the scheduler
+                locker.unlock();
+                executor_.endPass();
+            }
+        }
+    });
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::proceedTasks()
+{
+    time_t current = clock_.now();
+    while (!tasks_.empty() && tasks_.top()->expired(current))
+    {
+        std::shared_ptr<Task> task = tasks_.pop();
+        if (tracer_)
+            tracer_->record(TraceEventType::Expire, task->get_id(), task->planned(), current);
+        executor_.dispatch(task, current);
+
+        if (task->repeatable())
+        {
+            task->calculate_new_planned(current);
+            tasksToRepeat_.push_back(std::move(task));
+        }
+    }
+
+    for (auto&& taskPtr : tasksToRepeat_)
+        tasks_.push(std::move(taskPtr));
+    tasksToRepeat_.clear();
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::onNewTime(const struct timeval& tval)
+{
+    time_t timestamp = getTimestampInMs(tval);
+    {
+        std::lock_guard<Mutex> locker(lock_);
+        clock_.set(timestamp);
+        if (Executor::synchronous)
+            proceedTasks();
+    }
+    // asynchronous executors end the pass on the dispatcher thread which ran it
+    if (Executor::synchronous)
+        executor_.endPass();
+    executor_.checkDeadlines(timestamp);
+    condition_.notify_one();
+    executor_.adjust();
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::addTask(std::shared_ptr<Task>&& task)
+{
+    if (tracer_)
+        tracer_->record(TraceEventType::Schedule, task->get_id(), task->planned(), clock_.now());
+
+    updated_ = true;
+    condition_.notify_one();
+    tasks_.push(std::move(task));
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::setTraceRecorder(const TraceRecorderPtr& tracer)
+{
+    std::lock_guard<Mutex> locker(lock_);
+    tracer_ = tracer;
+    executor_.setTraceRecorder(tracer);
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+void BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::cancelTask(CronIdentifier key)
+{
+    {
+        std::lock_guard<Mutex> locker(lock_);
+        std::shared_ptr<Task> task = tasks_.erase(key);
+        if (tracer_)
+            tracer_->record(TraceEventType::Cancel, key, task ? task->planned() : 0, clock_.now());
+        if (task)
+        {
+            // stops runs of the repeatable task which are already dispatched
+            task->token()->cancel();
+            updated_ = true;
+            condition_.notify_one();
+            return;
+        }
+    }
+
+    executor_.cancel(key);
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+time_t BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::getTimestampInMs(const struct timeval& tval)
+{
+    return tval.tv_sec * 1000 + tval.tv_usec / 1000;
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+typename BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::CronIdentifier
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::scheduleAt(const struct timeval& plannedTval,
+    Callback&& callback)
+{
+    return scheduleAt(plannedTval, std::move(callback), false);
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+typename BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::CronIdentifier
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::scheduleAt(const struct timeval& plannedTval,
+    Callback&& callback, bool repeatable)
+{
+    return scheduleAt(plannedTval, std::move(callback), repeatable, nullptr);
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+typename BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::CronIdentifier
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::scheduleAt(const struct timeval& plannedTval,
+    Callback&& callback, bool repeatable, const ContextCPtr& ctx)
+{
+    std::time_t planned = getTimestampInMs(plannedTval);
+    std::lock_guard<Mutex> locker(lock_);
+    std::shared_ptr<Task> task = std::make_shared<Task>(
+        planned, clock_.now(), std::move(callback), repeatable, lastTaskId_++, ctx);
+    addTask(std::move(task));
+    return lastTaskId_ - 1;
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+typename BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::CronIdentifier
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::scheduleAt(const struct timeval& plannedTval,
+    CancellableCallback&& callback, bool repeatable, const ContextCPtr& ctx,
+    std::chrono::milliseconds deadline)
+{
+    return scheduleAt(plannedTval, std::move(callback), repeatable, ctx, deadline, false);
+}
+
+template<template<class> class TimerStore, class Executor, class Clock, class TaskCallback>
+typename BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::CronIdentifier
+BasicCronScheduler<TimerStore, Executor, Clock, TaskCallback>::scheduleAt(const struct timeval& plannedTval,
+    CancellableCallback&& callback, bool repeatable, const ContextCPtr& ctx,
+    std::chrono::milliseconds deadline, bool inlined)
+{
+    std::time_t planned = getTimestampInMs(plannedTval);
+    std::lock_guard<Mutex> locker(lock_);
+    std::shared_ptr<Task> task = std::make_shared<Task>(planned, clock_.now(),
+        std::move(callback), repeatable, lastTaskId_++, ctx, deadline.count(), inlined);
+    addTask(std::move(task));
+    return lastTaskId_ - 1;
+}
+
+} // namespace cron
+
+#endif // BASICCRONSCHEDULER_H_
@@ -0,0 +1,48 @@
+#ifndef CANCELLATIONTOKEN_H_
+#define CANCELLATIONTOKEN_H_
+
+#include <atomic>
+#include <memory>
+
+namespace cron
+{
+
+// Cooperative cancellation flag handed to the running callback.
+// A token created with a parent is also considered cancelled once the parent is,
+// so cancelling a task stops all of its runs while a watchdog may stop a single run.
+class CancellationToken
+{
+public:
+    CancellationToken() : cancelled_(false)
+    {}
+
+    explicit CancellationToken(const std::shared_ptr<const CancellationToken>& parent) :
+        cancelled_(false),
+        parent_(parent)
+    {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator= (const CancellationToken&) = delete;
+
+public:
+    void cancel()
+    {
+        cancelled_.store(true, std::memory_order_release);
+    }
+
+    bool cancelled() const
+    {
+        return cancelled_.load(std::memory_order_acquire) || (parent_ && parent_->cancelled());
+    }
+
+private:
+    std::atomic<bool> cancelled_;
+    std::shared_ptr<const CancellationToken> parent_;
+};
+
+typedef std::shared_ptr<CancellationToken> CancellationTokenPtr;
+typedef std::shared_ptr<const CancellationToken> CancellationTokenCPtr;
+
+} // namespace cron
+
+#endif // CANCELLATIONTOKEN_H_
@@ -0,0 +1,154 @@
+#ifndef CRONTASK_H_
+#define CRONTASK_H_
+
+#include <ctime>
+#include <memory>
+
+#include "CancellationToken.h"
+#include "Context.h"
+#include "IScheduler.h"
+
+namespace cron
+{
+
+// TaskCallback is invoked as callback(context, token)
+template<class TaskCallback>
+class BasicCronTask
+{
+public:
+    using Callback =  IScheduler::Callback;
+    using CancellableCallback = TaskCallback;
+    using CronIdentifier = IScheduler::CronIdentifier;
+
+public:
+    BasicCronTask() = delete;
+    explicit BasicCronTask(time_t planned, time_t current, Callback&& callback,
+        bool repeat, unsigned id, const ContextCPtr& context);
+    explicit BasicCronTask(time_t planned, time_t current, CancellableCallback&& callback,
+        bool repeat, unsigned id, const ContextCPtr& context, time_t deadline, bool inlined = false);
+
+public:
+    bool expired(time_t timestamp) const;
+    bool repeatable() const;
+    // inline tasks are executed by the dispatcher thread when the executor supports it
+    bool inlined() const;
+    void execute(const CancellationTokenCPtr& token) const;
+    void calculate_new_planned(time_t timestamp);
+    time_t planned() const;
+    time_t deadline() const;
+    CronIdentifier get_id() const;
+    const CancellationTokenPtr& token() const;
+
+private:
+    bool repeat_;
+    bool inlined_;
+    // kept apart from callback_ so plain callbacks are not wrapped into another std::function,
+    // only one of them is set
+    Callback plainCallback_;
+    CancellableCallback callback_;
+    ContextCPtr context_;
+    CronIdentifier identifier_;
+    time_t interval_;
+    time_t planned_;
+    time_t deadline_;
+    CancellationTokenPtr token_;
+};
+
+struct taskComparator {
+    template<class TaskPtr>
+    bool operator() (const TaskPtr &lhs, const TaskPtr &rhs) const
+    {
+        return lhs->planned() < rhs->planned();
+    }
+};
+
+template<class TaskCallback>
+BasicCronTask<TaskCallback>::BasicCronTask(time_t planned, time_t current, Callback&& callback,
+    bool repeat, unsigned id, const ContextCPtr& ctx) :
+        repeat_(repeat),
+        inlined_(false),
+        plainCallback_(std::move(callback)),
+        callback_(),
+        context_(ctx),
+        identifier_(id),
+        interval_(planned - current),
+        planned_(planned),
+        deadline_(0),
+        token_(std::make_shared<CancellationToken>())
+{}
+
+template<class TaskCallback>
+BasicCronTask<TaskCallback>::BasicCronTask(time_t planned, time_t current, CancellableCallback&& callback,
+    bool repeat, unsigned id, const ContextCPtr& ctx, time_t deadline, bool inlined) :
+        repeat_(repeat),
+        inlined_(inlined),
+        plainCallback_(),
+        callback_(std::move(callback)),
+        context_(ctx),
+        identifier_(id),
+        interval_(planned - current),
+        planned_(planned),
+        deadline_(deadline),
+        token_(std::make_shared<CancellationToken>())
+{}
+
+template<class TaskCallback>
+bool BasicCronTask<TaskCallback>::expired(time_t current) const
+{
+    return planned_ <= current;
+}
+
+template<class TaskCallback>
+time_t BasicCronTask<TaskCallback>::planned() const
+{
+    return planned_;
+}
+
+template<class TaskCallback>
+bool BasicCronTask<TaskCallback>::repeatable() const
+{
+    return repeat_;
+}
+
+template<class TaskCallback>
+bool BasicCronTask<TaskCallback>::inlined() const
+{
+    return inlined_;
+}
+
+template<class TaskCallback>
+void BasicCronTask<TaskCallback>::calculate_new_planned(time_t timestamp)
+{
+    planned_ = timestamp + interval_;
+}
+
+template<class TaskCallback>
+time_t BasicCronTask<TaskCallback>::deadline() const
+{
+    return deadline_;
+}
+
+template<class TaskCallback>
+void BasicCronTask<TaskCallback>::execute(const CancellationTokenCPtr& token) const
+{
+    if (plainCallback_)
+        plainCallback_(context_);
+    else
+        callback_(context_, token);
+}
+
+template<class TaskCallback>
+const CancellationTokenPtr& BasicCronTask<TaskCallback>::token() const
+{
+    return token_;
+}
+
+template<class TaskCallback>
+typename BasicCronTask<TaskCallback>::CronIdentifier BasicCronTask<TaskCallback>::get_id() const
+{
+    return identifier_;
+}
+
+} // namespace cron
+
+#endif // CRONTASK_H_
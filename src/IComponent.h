@@ -1,6 +1,8 @@
 #ifndef ICOMPONENT_H_
 #define ICOMPONENT_H_
 
+#include <string>
+
 namespace cron
 {
 
@@ -1,6 +1,10 @@
 #ifndef SCHEDULERINTERFACE_H_
 #define SCHEDULERINTERFACE_H_
 
+#include <chrono>
+#include <functional>
+
+#include "CancellationToken.h"
 #include "Context.h"
 
 namespace cron
@@ -11,12 +15,15 @@ class IScheduler
 public:
     using CronIdentifier = unsigned;
     using Callback = std::function<void(const ContextCPtr& ctx)> ;
+    using CancellableCallback = std::function<void(const ContextCPtr& ctx, const CancellationTokenCPtr& token)>;
 
 public:
     virtual void onNewTime(const struct  timeval& param) = 0;
     virtual CronIdentifier scheduleAt(const struct timeval& executeAt, Callback&& callback) = 0;
     virtual CronIdentifier scheduleAt(const struct timeval& executeAt, Callback&& callback, bool repeat) = 0;
     virtual CronIdentifier scheduleAt(const struct timeval& , Callback&& , bool repeatable, const ContextCPtr& ctx) = 0;;
+    virtual CronIdentifier scheduleAt(const struct timeval& , CancellableCallback&& , bool repeatable,
+        const ContextCPtr& ctx, std::chrono::milliseconds deadline) = 0;
     virtual  void cancelTask(CronIdentifier key)= 0;
 };
 
@@ -0,0 +1,153 @@
+#include "PoolExecutor.h"
+
+#include <utility>
+
+namespace cron
+{
+
+namespace
+{
+
+const std::chrono::microseconds kDefaultInlineBudget(50);
+
+} // namespace
+
+PoolExecutor::PoolExecutor(unsigned threadsAmount) :
+    runSlots_(threadsAmount),
+    inlineBudgetNs_(std::chrono::duration_cast<std::chrono::nanoseconds>(kDefaultInlineBudget).count()),
+    inlineRunsAmount_(0),
+    inlineFallbacksAmount_(0),
+    overrunsAmount_(0),
+    lastCheckMs_(0),
+    pool_(threadsAmount)
+{ }
+
+PoolExecutor::PoolExecutor(unsigned minThreadsAmount, unsigned maxThreadsAmount,
+    std::chrono::milliseconds growThreshold, std::chrono::milliseconds idleTimeout) :
+    runSlots_(maxThreadsAmount),
+    inlineBudgetNs_(std::chrono::duration_cast<std::chrono::nanoseconds>(kDefaultInlineBudget).count()),
+    inlineRunsAmount_(0),
+    inlineFallbacksAmount_(0),
+    overrunsAmount_(0),
+    lastCheckMs_(0),
+    pool_(minThreadsAmount, maxThreadsAmount, growThreshold, idleTimeout)
+{ }
+
+time_t PoolExecutor::beginRun(CronIdentifier id, time_t deadline, const CancellationTokenPtr& token)
+{
+    std::lock_guard<std::mutex> locker(runLock_);
+    RunSlot& slot = runSlots_[threadpool::ThreadPool::currentWorker()];
+    slot.token = token;
+    slot.id = id;
+    slot.deadline = deadline;
+    slot.startedAt = lastCheckMs_;
+    slot.overrun = false;
+    return slot.startedAt;
+}
+
+time_t PoolExecutor::endRun(CronIdentifier id, bool repeatable)
+{
+    std::lock_guard<std::mutex> locker(runLock_);
+    runSlots_[threadpool::ThreadPool::currentWorker()] = RunSlot();
+    if (!repeatable)
+        dispatched_.erase(id);
+    return lastCheckMs_;
+}
+
+void PoolExecutor::endPass()
+{
+    if (inlineRuns_.empty())
+        return;
+
+    // the first task is always inlined unless the budget is zero
+    std::chrono::nanoseconds budget(inlineBudgetNs_.load());
+    auto start = threadpool::ThreadPool::Clock::now();
+    for (auto&& inlineRun : inlineRuns_)
+    {
+        bool inlined = threadpool::ThreadPool::Clock::now() - start < budget;
+        inlineRun.run(*this, inlineRun, inlined);
+        if (inlined)
+            inlineRunsAmount_++;
+        else
+            inlineFallbacksAmount_++;
+    }
+    inlineRuns_.clear();
+}
+
+uint64_t PoolExecutor::getInlineRunsAmount() const
+{
+    return inlineRunsAmount_;
+}
+
+uint64_t PoolExecutor::getInlineFallbacksAmount() const
+{
+    return inlineFallbacksAmount_;
+}
+
+void PoolExecutor::checkDeadlines(time_t timestamp)
+{
+    lastCheckMs_ = timestamp;
+
+    std::vector<std::pair<CronIdentifier, time_t>> overruns;
+    OverrunHandler handler;
+    {
+        std::lock_guard<std::mutex> locker(runLock_);
+        for (auto&& slot : runSlots_)
+        {
+            if (!slot.token || slot.overrun || slot.deadline == 0)
+                continue;
+
+            time_t elapsed = timestamp - slot.startedAt;
+            if (elapsed > slot.deadline)
+            {
+                slot.overrun = true;
+                slot.token->cancel();
+                overruns.emplace_back(slot.id, elapsed);
+            }
+        }
+        handler = overrunHandler_;
+    }
+
+    overrunsAmount_ += overruns.size();
+    if (handler)
+    {
+        for (auto&& overrun : overruns)
+            handler(overrun.first, overrun.second);
+    }
+}
+
+void PoolExecutor::cancel(CronIdentifier id)
+{
+    std::lock_guard<std::mutex> locker(runLock_);
+    auto it = dispatched_.find(id);
+    if (it != dispatched_.end())
+        it->second->cancel();
+}
+
+void PoolExecutor::adjust()
+{
+    pool_.adjust();
+}
+
+void PoolExecutor::setTraceRecorder(const TraceRecorderPtr& tracer)
+{
+    tracer_ = tracer;
+}
+
+void PoolExecutor::setOverrunHandler(OverrunHandler&& handler)
+{
+    std::lock_guard<std::mutex> locker(runLock_);
+    overrunHandler_ = std::move(handler);
+}
+
+unsigned PoolExecutor::getOverrunsAmount() const
+{
+    return overrunsAmount_;
+}
+
+threadpool::ThreadPool::Statistics PoolExecutor::getPoolStatistics() const
+{
+    return pool_.statistics();
+}
+
+} // namespace cron
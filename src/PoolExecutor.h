@@ -0,0 +1,203 @@
+#ifndef POOLEXECUTOR_H_
+#define POOLEXECUTOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "IScheduler.h"
+#include "ThreadPool/ThreadPool.h"
+#include "TraceRecorder.h"
+
+namespace cron
+{
+
+// runs expired tasks on the thread pool and watches their deadlines
+class PoolExecutor
+{
+public:
+    using CronIdentifier = IScheduler::CronIdentifier;
+    using OverrunHandler = std::function<void(CronIdentifier id, time_t elapsedMs)>;
+
+    static constexpr bool synchronous = false;
+
+public:
+    explicit PoolExecutor(unsigned threadsAmount);
+    PoolExecutor(unsigned minThreadsAmount, unsigned maxThreadsAmount,
+        std::chrono::milliseconds growThreshold, std::chrono::milliseconds idleTimeout);
+
+public:
+    template<class Loop>
+    void start(Loop&& loop)
+    {
+        pool_.enqueue(std::forward<Loop>(loop));
+    }
+
+    // called by the dispatcher thread under the scheduler lock, inline tasks are postponed to endPass()
+    template<class Task>
+    void dispatch(const std::shared_ptr<Task>& task, time_t timestamp);
+    // called by the dispatcher thread without the lock after every expiry pass, never by onNewTime()
+    void endPass();
+
+    template<class Rep, class Period>
+    void setInlineBudget(const std::chrono::duration<Rep, Period>& budget)
+    {
+        inlineBudgetNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count();
+    }
+
+    uint64_t getInlineRunsAmount() const;
+    uint64_t getInlineFallbacksAmount() const;
+
+    void checkDeadlines(time_t timestamp);
+    void cancel(CronIdentifier id);
+    void adjust();
+    // the scheduler calls it and dispatch() under the same lock, runs get the tracer from dispatch()
+    void setTraceRecorder(const TraceRecorderPtr& tracer);
+    void setOverrunHandler(OverrunHandler&& handler);
+    unsigned getOverrunsAmount() const;
+    threadpool::ThreadPool::Statistics getPoolStatistics() const;
+
+private:
+    // state of the run occupying a pool worker, scanned by the watchdog on every time update
+    struct RunSlot
+    {
+        CancellationTokenPtr token;
+        CronIdentifier id = 0;
+        time_t deadline = 0;
+        time_t startedAt = 0;
+        bool overrun = false;
+    };
+
+    // inline task together with the way to run it, keeps the executor independent of the task type
+    struct InlineRun
+    {
+        std::shared_ptr<void> task;
+        // captured under the scheduler lock as endPass() runs without it
+        time_t planned;
+        TraceRecorderPtr tracer;
+        void (*run)(PoolExecutor& executor, const InlineRun& inlineRun, bool inlined);
+    };
+
+private:
+    // planned is the time the run fired at, the task is already rescheduled when the run starts
+    template<class Task>
+    void enqueue(const std::shared_ptr<Task>& task, time_t planned, const TraceRecorderPtr& tracer);
+    template<class Task>
+    void runInline(const std::shared_ptr<Task>& task, time_t planned, const TraceRecorderPtr& tracer);
+    template<class Task>
+    static void proceedInline(PoolExecutor& executor, const InlineRun& inlineRun, bool inlined);
+
+    // both return the time of the last watchdog check
+    time_t beginRun(CronIdentifier id, time_t deadline, const CancellationTokenPtr& token);
+    time_t endRun(CronIdentifier id, bool repeatable);
+
+private:
+    // run bookkeeping must outlive pool_ as workers access it until joined
+    std::mutex runLock_;
+    std::vector<RunSlot> runSlots_;
+    std::unordered_map<CronIdentifier, CancellationTokenPtr> dispatched_;
+    OverrunHandler overrunHandler_;
+    TraceRecorderPtr tracer_;
+    // filled by dispatch() and drained by endPass() on the dispatcher thread, reused between the passes
+    std::vector<InlineRun> inlineRuns_;
+    std::atomic<int64_t> inlineBudgetNs_;
+    std::atomic<uint64_t> inlineRunsAmount_;
+    std::atomic<uint64_t> inlineFallbacksAmount_;
+    std::atomic<unsigned> overrunsAmount_;
+    std::atomic<time_t> lastCheckMs_;
+    threadpool::ThreadPool pool_;
+};
+
+template<class Task>
+void PoolExecutor::dispatch(const std::shared_ptr<Task>& task, time_t)
+{
+    // one-shot task has left the timer store, cancelTask() finds it here until its run ends
+    if (!task->repeatable())
+    {
+        std::lock_guard<std::mutex> locker(runLock_);
+        dispatched_[task->get_id()] = task->token();
+    }
+
+    if (task->inlined())
+        inlineRuns_.push_back(InlineRun{ task, task->planned(), tracer_, &PoolExecutor::proceedInline<Task> });
+    else
+        enqueue(task, task->planned(), tracer_);
+}
+
+template<class Task>
+void PoolExecutor::proceedInline(PoolExecutor& executor, const InlineRun& inlineRun, bool inlined)
+{
+    auto typedTask = std::static_pointer_cast<Task>(inlineRun.task);
+    if (inlined)
+        executor.runInline(typedTask, inlineRun.planned, inlineRun.tracer);
+    else
+        executor.enqueue(typedTask, inlineRun.planned, inlineRun.tracer);
+}
+
+template<class Task>
+void PoolExecutor::runInline(const std::shared_ptr<Task>& task, time_t planned, const TraceRecorderPtr& tracer)
+{
+    // task might be cancelled after the expiry pass has released the scheduler lock
+    if (!task->token()->cancelled())
+    {
+        if (tracer)
+            tracer->record(TraceEventType::DispatchStart, task->get_id(), planned, lastCheckMs_);
+
+        try
+        {
+            task->execute(task->token());
+        }
+        catch (...)
+        {
+            // the same as for the pool tasks
+        }
+
+        if (tracer)
+            tracer->record(TraceEventType::DispatchEnd, task->get_id(), planned, lastCheckMs_);
+    }
+
+    if (!task->repeatable())
+    {
+        std::lock_guard<std::mutex> locker(runLock_);
+        dispatched_.erase(task->get_id());
+    }
+}
+
+template<class Task>
+void PoolExecutor::enqueue(const std::shared_ptr<Task>& task, time_t planned, const TraceRecorderPtr& tracer)
+{
+    // every run gets its own token so the watchdog can abort a single overrunning run
+    auto token = std::make_shared<CancellationToken>(task->token());
+    pool_.enqueue([this, task, planned, token, tracer] () {
+        time_t startedAt = beginRun(task->get_id(), task->deadline(), token);
+        if (tracer)
+            tracer->record(TraceEventType::DispatchStart, task->get_id(), planned, startedAt);
+
+        // task might be cancelled while waiting in the pool queue
+        if (!token->cancelled())
+        {
+            try
+            {
+                task->execute(token);
+            }
+            catch (...)
+            {
+                // the future is never checked, the run slot must be released anyway
+            }
+        }
+
+        time_t finishedAt = endRun(task->get_id(), task->repeatable());
+        if (tracer)
+            tracer->record(TraceEventType::DispatchEnd, task->get_id(), planned, finishedAt);
+    });
+}
+
+} // namespace cron
+
+#endif // POOLEXECUTOR_H_
@@ -0,0 +1,75 @@
+#ifndef RINGEXECUTOR_H_
+#define RINGEXECUTOR_H_
+
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include "BasicCronScheduler.h"
+#include "CancellationToken.h"
+#include "Context.h"
+#include "SharedEventRing.h"
+#include "TraceRecorder.h"
+
+namespace cron
+{
+
+// publishes ids of the expired tasks to the other processes of the host instead of running
+// the task callbacks, which are ignored and could be nullptr
+class RingExecutor
+{
+public:
+    using Callback = void(*)(const ContextCPtr& ctx, const CancellationTokenCPtr& token);
+
+    static constexpr bool synchronous = true;
+
+public:
+    RingExecutor(const std::string& name, size_t capacity) :
+        ring_(SharedEventRing::create(name, capacity))
+    {}
+
+public:
+    template<class Task>
+    void dispatch(const std::shared_ptr<Task>& task, time_t timestamp)
+    {
+        if (tracer_)
+            tracer_->record(TraceEventType::DispatchStart, task->get_id(), task->planned(), timestamp);
+        ring_->publish(SharedEvent{ task->get_id(), task->planned(), SharedEventRing::monotonicNs() });
+        if (tracer_)
+            tracer_->record(TraceEventType::DispatchEnd, task->get_id(), task->planned(), timestamp);
+    }
+
+    void setTraceRecorder(const TraceRecorderPtr& tracer)
+    {
+        tracer_ = tracer;
+    }
+
+    void checkDeadlines(time_t)
+    {}
+
+    void cancel(IScheduler::CronIdentifier)
+    {}
+
+    void adjust()
+    {}
+
+    void endPass()
+    {}
+
+    unsigned getConsumersAmount() const
+    {
+        return ring_->getConsumersAmount();
+    }
+
+private:
+    SharedEventRingPtr ring_;
+    TraceRecorderPtr tracer_;
+};
+
+// owns the schedules of the host, consumers subscribe with SharedEventReader
+using SharedCronScheduler = BasicCronScheduler<MultisetTimerStore, RingExecutor, ExternalClock,
+    RingExecutor::Callback>;
+
+} // namespace cron
+
+#endif // RINGEXECUTOR_H_
@@ -0,0 +1,228 @@
+#ifndef SCHEDULERPOLICIES_H_
+#define SCHEDULERPOLICIES_H_
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "CronTask.h"
+#include "IScheduler.h"
+#include "TraceRecorder.h"
+
+namespace cron
+{
+
+// lock policy for the single-threaded deployments
+struct NullMutex
+{
+    void lock() {}
+    void unlock() {}
+    bool try_lock() { return true; }
+};
+
+//========================================
+// Timer stores: ordered by the planned time, guarded by Mutex
+//========================================
+
+template<class Task>
+class MultisetTimerStore
+{
+public:
+    using Mutex = std::mutex;
+    using TaskPtr = std::shared_ptr<Task>;
+    using Container = std::multiset<TaskPtr, taskComparator>;
+
+public:
+    bool empty() const
+    {
+        return tasks_.empty();
+    }
+
+    const TaskPtr& top() const
+    {
+        return *tasks_.begin();
+    }
+
+    TaskPtr pop()
+    {
+        TaskPtr task = *tasks_.begin();
+        tasks_.erase(tasks_.begin());
+        return task;
+    }
+
+    void push(TaskPtr&& task)
+    {
+        tasks_.insert(std::move(task));
+    }
+
+    TaskPtr erase(IScheduler::CronIdentifier id)
+    {
+        for (auto it = tasks_.begin(); it != tasks_.end(); it++)
+        {
+            if ((*it)->get_id() == id)
+            {
+                TaskPtr task = *it;
+                tasks_.erase(it);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    Container tasks_;
+};
+
+// binary heap over a vector: rescheduling a repeatable task never allocates,
+// tasks with the same planned time are not kept in the insertion order
+template<class Task>
+class HeapTimerStore
+{
+public:
+    using Mutex = NullMutex;
+    using TaskPtr = std::shared_ptr<Task>;
+
+public:
+    bool empty() const
+    {
+        return tasks_.empty();
+    }
+
+    const TaskPtr& top() const
+    {
+        return tasks_.front();
+    }
+
+    TaskPtr pop()
+    {
+        std::pop_heap(tasks_.begin(), tasks_.end(), later);
+        TaskPtr task = std::move(tasks_.back());
+        tasks_.pop_back();
+        return task;
+    }
+
+    void push(TaskPtr&& task)
+    {
+        tasks_.push_back(std::move(task));
+        std::push_heap(tasks_.begin(), tasks_.end(), later);
+    }
+
+    TaskPtr erase(IScheduler::CronIdentifier id)
+    {
+        auto it = std::find_if(tasks_.begin(), tasks_.end(),
+            [id] (const TaskPtr& task) { return task->get_id() == id; });
+        if (it == tasks_.end())
+            return nullptr;
+
+        TaskPtr task = std::move(*it);
+        *it = std::move(tasks_.back());
+        tasks_.pop_back();
+        std::make_heap(tasks_.begin(), tasks_.end(), later);
+        return task;
+    }
+
+    void reserve(size_t amount)
+    {
+        tasks_.reserve(amount);
+    }
+
+private:
+    static bool later(const TaskPtr& lhs, const TaskPtr& rhs)
+    {
+        return rhs->planned() < lhs->planned();
+    }
+
+private:
+    std::vector<TaskPtr> tasks_;
+};
+
+//========================================
+// Clocks: storage of the time passed to onNewTime()
+//========================================
+
+class ExternalClock
+{
+public:
+    ExternalClock() : timestamp_(0)
+    {}
+
+    time_t now() const
+    {
+        return timestamp_;
+    }
+
+    void set(time_t timestamp)
+    {
+        timestamp_ = timestamp;
+    }
+
+private:
+    std::atomic<time_t> timestamp_;
+};
+
+class UnsyncExternalClock
+{
+public:
+    time_t now() const
+    {
+        return timestamp_;
+    }
+
+    void set(time_t timestamp)
+    {
+        timestamp_ = timestamp;
+    }
+
+private:
+    time_t timestamp_ = 0;
+};
+
+//========================================
+// Executors: PoolExecutor.h provides the asynchronous one
+//========================================
+
+// runs expired tasks on the thread calling onNewTime()
+class InlineExecutor
+{
+public:
+    static constexpr bool synchronous = true;
+
+public:
+    template<class Task>
+    void dispatch(const std::shared_ptr<Task>& task, time_t timestamp)
+    {
+        if (tracer_)
+            tracer_->record(TraceEventType::DispatchStart, task->get_id(), task->planned(), timestamp);
+        task->execute(task->token());
+        if (tracer_)
+            tracer_->record(TraceEventType::DispatchEnd, task->get_id(), task->planned(), timestamp);
+    }
+
+    void setTraceRecorder(const TraceRecorderPtr& tracer)
+    {
+        tracer_ = tracer;
+    }
+
+    void checkDeadlines(time_t)
+    {}
+
+    void cancel(IScheduler::CronIdentifier)
+    {}
+
+    void adjust()
+    {}
+
+    void endPass()
+    {}
+
+private:
+    TraceRecorderPtr tracer_;
+};
+
+} // namespace cron
+
+#endif // SCHEDULERPOLICIES_H_
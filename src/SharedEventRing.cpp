@@ -0,0 +1,284 @@
+#include "SharedEventRing.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace cron
+{
+
+namespace
+{
+
+const uint32_t kRingMagic = 0x43524f4e;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+    "shared memory ring requires lock-free atomics");
+
+std::runtime_error systemError(const std::string& what, const std::string& name)
+{
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+struct SharedEventRing::Header
+{
+    uint32_t magic;
+    uint32_t capacity;
+    std::atomic<uint64_t> head;
+    // futex word, bumped on every publish
+    std::atomic<uint32_t> generation;
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> consumers;
+};
+
+// fields are atomic as readers may access the slot while the producer overwrites it
+struct SharedEventRing::Slot
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint32_t> id;
+    std::atomic<int64_t> planned;
+    std::atomic<int64_t> publishedNs;
+};
+
+SharedEventRingPtr SharedEventRing::create(const std::string& name, size_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        throw std::invalid_argument("ring capacity must be a power of two");
+    // the header keeps the capacity in 32 bits
+    if (capacity > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("ring capacity exceeds 2^31");
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throw systemError("shm_open", name);
+
+    size_t size = sizeof(Header) + capacity * sizeof(Slot);
+    if (ftruncate(fd, size) != 0)
+    {
+        auto error = systemError("ftruncate", name);
+        close(fd);
+        shm_unlink(name.c_str());
+        throw error;
+    }
+
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        auto error = systemError("mmap", name);
+        shm_unlink(name.c_str());
+        throw error;
+    }
+
+    // ftruncate zero-fills the segment, which is a valid state for the atomics
+    Header* header = static_cast<Header*>(memory);
+    header->capacity = capacity;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kRingMagic;
+
+    return SharedEventRingPtr(new SharedEventRing(memory, size, name, true));
+}
+
+SharedEventRingPtr SharedEventRing::open(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+        throw systemError("shm_open", name);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+    {
+        close(fd);
+        throw std::runtime_error("invalid shared ring " + name);
+    }
+
+    size_t size = st.st_size;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        throw systemError("mmap", name);
+
+    Header* header = static_cast<Header*>(memory);
+    uint32_t capacity = header->capacity;
+    if (header->magic != kRingMagic || capacity == 0 || (capacity & (capacity - 1)) != 0
+        || sizeof(Header) + size_t(capacity) * sizeof(Slot) > size)
+    {
+        munmap(memory, size);
+        throw std::runtime_error("invalid shared ring " + name);
+    }
+
+    return SharedEventRingPtr(new SharedEventRing(memory, size, name, false));
+}
+
+int64_t SharedEventRing::monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+SharedEventRing::SharedEventRing(void* memory, size_t size, const std::string& name, bool owner) :
+    header_(static_cast<Header*>(memory)),
+    slots_(reinterpret_cast<Slot*>(static_cast<char*>(memory) + sizeof(Header))),
+    size_(size),
+    name_(name),
+    owner_(owner)
+{}
+
+SharedEventRing::~SharedEventRing()
+{
+    munmap(header_, size_);
+    if (owner_)
+        shm_unlink(name_.c_str());
+}
+
+SharedEventRing::Slot& SharedEventRing::slot(uint64_t sequence) const
+{
+    return slots_[sequence & (header_->capacity - 1)];
+}
+
+void SharedEventRing::publish(const SharedEvent& event)
+{
+    uint64_t sequence = header_->head.load(std::memory_order_relaxed);
+    Slot& target = slot(sequence);
+
+    // readers validate the sequence before and after reading the payload
+    target.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    target.id.store(event.id, std::memory_order_relaxed);
+    target.planned.store(event.planned, std::memory_order_relaxed);
+    target.publishedNs.store(event.publishedNs, std::memory_order_relaxed);
+    target.sequence.store(sequence + 1, std::memory_order_release);
+    header_->head.store(sequence + 1, std::memory_order_release);
+
+    // pairs with the waiters increment in waitFor(): either the waiter sees the new
+    // generation and does not sleep or the producer sees the waiter and wakes it
+    header_->generation.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->waiters.load(std::memory_order_seq_cst) > 0)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header_->generation),
+            FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+bool SharedEventRing::read(uint64_t sequence, SharedEvent& event) const
+{
+    // slot stores sequence + 1, so zero means the slot is being written
+    const Slot& source = slot(sequence);
+    if (source.sequence.load(std::memory_order_acquire) != sequence + 1)
+        return false;
+
+    event.id = source.id.load(std::memory_order_relaxed);
+    event.planned = source.planned.load(std::memory_order_relaxed);
+    event.publishedNs = source.publishedNs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return source.sequence.load(std::memory_order_relaxed) == sequence + 1;
+}
+
+void SharedEventRing::waitFor(uint64_t sequence, std::chrono::milliseconds timeout) const
+{
+    uint32_t generation = header_->generation.load(std::memory_order_seq_cst);
+    if (header_->head.load(std::memory_order_acquire) > sequence)
+        return;
+
+    struct timespec ts;
+    ts.tv_sec = timeout.count() / 1000;
+    ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+
+    header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header_->generation),
+        FUTEX_WAIT, generation, &ts, nullptr, 0);
+    header_->waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+uint64_t SharedEventRing::head() const
+{
+    return header_->head.load(std::memory_order_acquire);
+}
+
+size_t SharedEventRing::capacity() const
+{
+    return header_->capacity;
+}
+
+void SharedEventRing::attach()
+{
+    header_->consumers.fetch_add(1);
+}
+
+void SharedEventRing::detach()
+{
+    header_->consumers.fetch_sub(1);
+}
+
+unsigned SharedEventRing::getConsumersAmount() const
+{
+    return header_->consumers.load();
+}
+
+SharedEventReader::SharedEventReader(const std::string& name) :
+    ring_(SharedEventRing::open(name)),
+    cursor_(ring_->head()),
+    lost_(0)
+{
+    ring_->attach();
+}
+
+SharedEventReader::~SharedEventReader()
+{
+    ring_->detach();
+}
+
+bool SharedEventReader::poll(SharedEvent& event)
+{
+    uint64_t head = ring_->head();
+    while (cursor_ < head)
+    {
+        // skip the events overwritten by the producer
+        if (head - cursor_ > ring_->capacity())
+        {
+            lost_ += head - ring_->capacity() - cursor_;
+            cursor_ = head - ring_->capacity();
+        }
+
+        if (ring_->read(cursor_++, event))
+            return true;
+
+        lost_++;
+        head = ring_->head();
+    }
+    return false;
+}
+
+bool SharedEventReader::wait(SharedEvent& event, std::chrono::milliseconds timeout)
+{
+    auto until = std::chrono::steady_clock::now() + timeout;
+    while (!poll(event))
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            until - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+            return false;
+        ring_->waitFor(cursor_, left);
+    }
+    return true;
+}
+
+uint64_t SharedEventReader::getLostAmount() const
+{
+    return lost_;
+}
+
+} // namespace cron
@@ -0,0 +1,94 @@
+#ifndef SHAREDEVENTRING_H_
+#define SHAREDEVENTRING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "IScheduler.h"
+
+namespace cron
+{
+
+struct SharedEvent
+{
+    IScheduler::CronIdentifier id;
+    int64_t planned;
+    // CLOCK_MONOTONIC is shared by all processes of the host
+    int64_t publishedNs;
+};
+
+// Single-producer broadcast ring in POSIX shared memory. Every reader sees every event
+// unless it falls more than capacity events behind. Readers sleep on a futex which the
+// producer wakes only when somebody is waiting. Linux only.
+class SharedEventRing
+{
+public:
+    // creates the segment, it is unlinked when the creator is destroyed
+    static std::shared_ptr<SharedEventRing> create(const std::string& name, size_t capacity);
+    static std::shared_ptr<SharedEventRing> open(const std::string& name);
+    static int64_t monotonicNs();
+
+public:
+    SharedEventRing(const SharedEventRing&) = delete;
+    SharedEventRing& operator= (const SharedEventRing&) = delete;
+    ~SharedEventRing();
+
+public:
+    // must be called from a single thread of a single process
+    void publish(const SharedEvent& event);
+    // false if the event is not published yet or has been overwritten
+    bool read(uint64_t sequence, SharedEvent& event) const;
+    // blocks until the event with the given sequence is published or timeout expires
+    void waitFor(uint64_t sequence, std::chrono::milliseconds timeout) const;
+
+    uint64_t head() const;
+    size_t capacity() const;
+
+    void attach();
+    void detach();
+    unsigned getConsumersAmount() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+private:
+    SharedEventRing(void* memory, size_t size, const std::string& name, bool owner);
+    Slot& slot(uint64_t sequence) const;
+
+private:
+    Header* header_;
+    Slot* slots_;
+    size_t size_;
+    std::string name_;
+    bool owner_;
+};
+
+typedef std::shared_ptr<SharedEventRing> SharedEventRingPtr;
+
+// consumer side of the ring, starts with the events published after its creation
+class SharedEventReader
+{
+public:
+    explicit SharedEventReader(const std::string& name);
+    SharedEventReader(const SharedEventReader&) = delete;
+    SharedEventReader& operator= (const SharedEventReader&) = delete;
+    ~SharedEventReader();
+
+public:
+    bool poll(SharedEvent& event);
+    bool wait(SharedEvent& event, std::chrono::milliseconds timeout);
+    uint64_t getLostAmount() const;
+
+private:
+    SharedEventRingPtr ring_;
+    uint64_t cursor_;
+    uint64_t lost_;
+};
+
+} // namespace cron
+
+#endif // SHAREDEVENTRING_H_
@@ -10,62 +10,189 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
 
-namespace cron 
+namespace cron
 {
 namespace threadpool
 {
 
 class ThreadPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Statistics
+    {
+        size_t threads = 0;
+        size_t idle = 0;
+        size_t queued = 0;
+        size_t grown = 0;
+        size_t retired = 0;
+        uint64_t dequeued = 0;
+        std::chrono::microseconds totalWait = std::chrono::microseconds(0);
+        std::chrono::microseconds maxWait = std::chrono::microseconds(0);
+    };
+
 public:
     ThreadPool(size_t);
+    // elastic mode: grows up to maxThreads when tasks wait in the queue longer than
+    // growThreshold and retires workers idle for idleTimeout down to minThreads,
+    // throws std::invalid_argument for minThreads > maxThreads or non-positive idleTimeout
+    ThreadPool(size_t minThreads, size_t maxThreads,
+        std::chrono::milliseconds growThreshold, std::chrono::milliseconds idleTimeout);
     template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) 
+    auto enqueue(F&& f, Args&&... args)
         -> std::future<typename std::result_of<F(Args...)>::type>;
     ~ThreadPool();
+    // amount of currently running workers
+    size_t size() const;
+    // upper bound of the worker indices
+    size_t capacity() const;
+    Statistics statistics() const;
+    // re-checks the backlog, lets an owner grow the pool when no new tasks are enqueued
+    void adjust();
+    // index of the pool worker running the caller, npos outside of the pool
+    static size_t currentWorker();
+
+    static const size_t npos = static_cast<size_t>(-1);
 private:
-    // need to keep track of threads so we can join them
+    static size_t& workerIndex();
+    void spawn();
+    void work(size_t index);
+    void growIfBacklogged(Clock::time_point now);
+
+    // need to keep track of threads so we can join them,
+    // slots of retired workers are reused by the next grown one
     std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::function<void()> > tasks;
-    
+    std::vector< bool > active;
+    // the task queue with the time each task was enqueued at
+    std::queue< std::pair< Clock::time_point, std::function<void()> > > tasks;
+
+    // elasticity settings
+    size_t minThreads;
+    std::chrono::milliseconds growThreshold;
+    std::chrono::milliseconds idleTimeout;
+    Clock::time_point lastGrow;
+
     // synchronization
-    std::mutex queue_mutex;
+    mutable std::mutex queue_mutex;
     std::condition_variable condition;
     bool stop;
+    Statistics stats;
 };
- 
+
 // the constructor just launches some amount of workers
 inline ThreadPool::ThreadPool(size_t threads)
-    :   stop(false)
+    :   ThreadPool(threads, threads, std::chrono::milliseconds(0), std::chrono::milliseconds(0))
 {
-    for(size_t i = 0;i<threads;++i)
-        workers.emplace_back(
-            [this]
+}
+
+inline ThreadPool::ThreadPool(size_t minThreads, size_t maxThreads,
+    std::chrono::milliseconds growThreshold, std::chrono::milliseconds idleTimeout)
+    :   workers(maxThreads),
+        active(workers.size(), false),
+        minThreads(minThreads),
+        growThreshold(growThreshold),
+        idleTimeout(idleTimeout),
+        lastGrow(Clock::now()),
+        stop(false)
+{
+    if(minThreads > maxThreads)
+        throw std::invalid_argument("ThreadPool minThreads exceeds maxThreads");
+    if(minThreads < maxThreads && idleTimeout <= std::chrono::milliseconds(0))
+        throw std::invalid_argument("elastic ThreadPool requires positive idleTimeout");
+
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    for(size_t i = 0;i<minThreads;++i)
+        spawn();
+}
+
+// must be called with queue_mutex held
+inline void ThreadPool::spawn()
+{
+    size_t index = 0;
+    while(active[index])
+        ++index;
+
+    // slot keeps the thread of a retired worker which has already left work()
+    if(workers[index].joinable())
+        workers[index].join();
+
+    active[index] = true;
+    ++stats.threads;
+    workers[index] = std::thread(&ThreadPool::work, this, index);
+}
+
+// must be called with queue_mutex held
+inline void ThreadPool::growIfBacklogged(Clock::time_point now)
+{
+    // the second threshold check is the hysteresis: a fresh worker gets
+    // a chance to drain the backlog before another one is added
+    if(stats.threads < workers.size() && stats.idle == 0 && !tasks.empty()
+        && now - tasks.front().first > growThreshold
+        && now - lastGrow > growThreshold)
+    {
+        lastGrow = now;
+        ++stats.grown;
+        spawn();
+    }
+}
+
+inline void ThreadPool::work(size_t index)
+{
+    workerIndex() = index;
+    for(;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(this->queue_mutex);
+            ++stats.idle;
+            auto ready = [this]{ return this->stop || !this->tasks.empty(); };
+            while(!ready())
             {
-                for(;;)
+                // only the workers above the minimum wake up to check whether to retire
+                if(stats.threads <= minThreads)
+                {
+                    this->condition.wait(lock);
+                }
+                else if(this->condition.wait_for(lock, idleTimeout) == std::cv_status::timeout
+                    && !ready() && stats.threads > minThreads
+                    && Clock::now() - lastGrow > idleTimeout)
                 {
-                    std::function<void()> task;
-
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock,
-                            [this]{ return this->stop || !this->tasks.empty(); });
-                        if(this->stop && this->tasks.empty())
-                            return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-
-                    task();
+                    --stats.idle;
+                    --stats.threads;
+                    ++stats.retired;
+                    active[index] = false;
+                    return;
                 }
             }
-        );
+            --stats.idle;
+            if(this->stop && this->tasks.empty())
+                return;
+
+            auto now = Clock::now();
+            auto wait = std::chrono::duration_cast<std::chrono::microseconds>(now - this->tasks.front().first);
+            task = std::move(this->tasks.front().second);
+            this->tasks.pop();
+
+            ++stats.dequeued;
+            stats.totalWait += wait;
+            stats.maxWait = std::max(stats.maxWait, wait);
+            if(!this->stop)
+                growIfBacklogged(now);
+        }
+
+        task();
+    }
 }
 
 // add new work item to the pool
 template<class F, class... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args) 
+auto ThreadPool::enqueue(F&& f, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using return_type = typename std::result_of<F(Args...)>::type;
@@ -73,7 +200,7 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
     auto task = std::make_shared< std::packaged_task<return_type()> >(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
-        
+
     std::future<return_type> res = task->get_future();
     {
         std::unique_lock<std::mutex> lock(queue_mutex);
@@ -82,12 +209,51 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
         if(stop)
             throw std::runtime_error("enqueue on stopped ThreadPool");
 
-        tasks.emplace([task](){ (*task)(); });
+        auto now = Clock::now();
+        tasks.emplace(now, [task](){ (*task)(); });
+        growIfBacklogged(now);
     }
     condition.notify_one();
     return res;
 }
 
+inline void ThreadPool::adjust()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if(!stop)
+        growIfBacklogged(Clock::now());
+}
+
+inline size_t ThreadPool::size() const
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    return stats.threads;
+}
+
+inline size_t ThreadPool::capacity() const
+{
+    return workers.size();
+}
+
+inline ThreadPool::Statistics ThreadPool::statistics() const
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    Statistics result = stats;
+    result.queued = tasks.size();
+    return result;
+}
+
+inline size_t ThreadPool::currentWorker()
+{
+    return workerIndex();
+}
+
+inline size_t& ThreadPool::workerIndex()
+{
+    static thread_local size_t index = npos;
+    return index;
+}
+
 // the destructor joins all threads
 inline ThreadPool::~ThreadPool()
 {
@@ -97,7 +263,8 @@ inline ThreadPool::~ThreadPool()
     }
     condition.notify_all();
     for(std::thread &worker: workers)
-        worker.join();
+        if(worker.joinable())
+            worker.join();
 }
 
 } // namespace threadpool
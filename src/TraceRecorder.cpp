@@ -0,0 +1,341 @@
+#include "TraceRecorder.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "ThreadPool/ThreadPool.h"
+
+namespace cron
+{
+
+constexpr uint16_t TraceEvent::kNoWorker;
+
+namespace
+{
+
+const char kTraceMagic[8] = { 'C', 'R', 'O', 'N', 'T', 'R', 'C', '1' };
+const uint32_t kTraceVersion = 1;
+const size_t kInitialFileSize = 1 << 20;
+
+std::atomic<uint64_t> lastRecorderId(0);
+
+std::runtime_error systemError(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+} // namespace
+
+// single-producer single-consumer ring owned by one recording thread
+struct TraceRecorder::Buffer
+{
+    explicit Buffer(size_t capacity) :
+        events(capacity),
+        head(0),
+        tail(0),
+        retired(false),
+        closed(false)
+    {}
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    // set by the exiting owner thread, the flusher frees the buffer once it is drained
+    std::atomic<bool> retired;
+    // set by the destroyed recorder, the owner thread releases the buffer on its next lookup
+    std::atomic<bool> closed;
+};
+
+TraceRecorder::TraceRecorder(const std::string& path, size_t threadBufferCapacity,
+    std::chrono::milliseconds flushInterval) :
+    recorderId_(++lastRecorderId),
+    bufferCapacity_(threadBufferCapacity),
+    dropped_(0),
+    fd_(-1),
+    mapped_(nullptr),
+    mappedSize_(0),
+    eventsAmount_(0),
+    failed_(false),
+    stop_(false)
+{
+    if (threadBufferCapacity == 0 || (threadBufferCapacity & (threadBufferCapacity - 1)) != 0)
+        throw std::invalid_argument("trace buffer capacity must be a power of two");
+
+    fd_ = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd_ < 0)
+        throw systemError("open", path);
+
+    try
+    {
+        ensureMapped(kInitialFileSize);
+    }
+    catch (...)
+    {
+        close(fd_);
+        throw;
+    }
+
+    TraceFileHeader* header = reinterpret_cast<TraceFileHeader*>(mapped_);
+    std::memcpy(header->magic, kTraceMagic, sizeof(kTraceMagic));
+    header->version = kTraceVersion;
+    header->eventSize = sizeof(TraceEvent);
+    header->eventsAmount = 0;
+
+    flusher_ = std::thread([this, flushInterval] {
+        std::unique_lock<std::mutex> locker(stopLock_);
+        while (!stop_)
+        {
+            stopCondition_.wait_for(locker, flushInterval);
+            locker.unlock();
+            try
+            {
+                flush();
+            }
+            catch (const std::exception&)
+            {
+                // recording has stopped, the file keeps the events flushed before the failure
+            }
+            locker.lock();
+        }
+    });
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    {
+        std::lock_guard<std::mutex> locker(stopLock_);
+        stop_ = true;
+    }
+    stopCondition_.notify_one();
+    flusher_.join();
+    {
+        std::lock_guard<std::mutex> locker(buffersLock_);
+        for (auto&& buffer : buffers_)
+            buffer->closed.store(true, std::memory_order_relaxed);
+    }
+    try
+    {
+        flush();
+    }
+    catch (const std::exception&)
+    {
+        // the header keeps the amount of the flushed events
+    }
+
+    // cut the preallocated tail off
+    munmap(mapped_, mappedSize_);
+    if (ftruncate(fd_, sizeof(TraceFileHeader) + eventsAmount_ * sizeof(TraceEvent)) != 0)
+    {
+        // the header keeps the amount of events, so the file is readable anyway
+    }
+    close(fd_);
+}
+
+TraceRecorder::Buffer* TraceRecorder::localBuffer()
+{
+    // buffers of the calling thread, retired when it exits
+    struct ThreadBuffers
+    {
+        ~ThreadBuffers()
+        {
+            for (auto&& entry : entries)
+                entry.second->retired.store(true, std::memory_order_release);
+        }
+
+        // thread may record into several recorders, ids are never reused
+        std::vector<std::pair<uint64_t, std::shared_ptr<Buffer>>> entries;
+    };
+
+    static thread_local ThreadBuffers cache;
+    for (auto&& entry : cache.entries)
+    {
+        if (entry.first == recorderId_)
+            return entry.second.get();
+    }
+
+    cache.entries.erase(std::remove_if(cache.entries.begin(), cache.entries.end(),
+        [] (const std::pair<uint64_t, std::shared_ptr<Buffer>>& entry)
+            { return entry.second->closed.load(std::memory_order_relaxed); }),
+        cache.entries.end());
+
+    std::lock_guard<std::mutex> locker(buffersLock_);
+    buffers_.push_back(std::make_shared<Buffer>(bufferCapacity_));
+    cache.entries.emplace_back(recorderId_, buffers_.back());
+    return buffers_.back().get();
+}
+
+void TraceRecorder::record(TraceEventType type, IScheduler::CronIdentifier id, time_t planned, time_t actual)
+{
+    Buffer* buffer = localBuffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    if (failed_.load(std::memory_order_relaxed)
+        || head - buffer->tail.load(std::memory_order_acquire) == bufferCapacity_)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t worker = threadpool::ThreadPool::currentWorker();
+    TraceEvent& event = buffer->events[head & (bufferCapacity_ - 1)];
+    event.type = static_cast<uint8_t>(type);
+    event.reserved = 0;
+    event.worker = worker < TraceEvent::kNoWorker ? static_cast<uint16_t>(worker) : TraceEvent::kNoWorker;
+    event.id = id;
+    event.planned = planned;
+    event.actual = actual;
+    event.timestampNs = monotonicNs();
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::ensureMapped(size_t size)
+{
+    if (size <= mappedSize_)
+        return;
+
+    // blocks are allocated upfront, otherwise a full disk raises SIGBUS on a write to the mapping
+    size_t newSize = std::max(size, mappedSize_ * 2);
+    int error = posix_fallocate(fd_, 0, newSize);
+    if (error != 0)
+    {
+        errno = error;
+        throw systemError("posix_fallocate", "trace file");
+    }
+
+    void* memory = mapped_
+        ? mremap(mapped_, mappedSize_, newSize, MREMAP_MAYMOVE)
+        : mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory == MAP_FAILED)
+        throw systemError("mmap", "trace file");
+
+    mapped_ = static_cast<char*>(memory);
+    mappedSize_ = newSize;
+}
+
+void TraceRecorder::flush()
+{
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    {
+        std::lock_guard<std::mutex> locker(buffersLock_);
+        buffers = buffers_;
+    }
+
+    std::exception_ptr error;
+    std::vector<Buffer*> drained;
+    std::lock_guard<std::mutex> locker(flushLock_);
+    for (auto&& buffer : buffers)
+    {
+        // loaded before the head: the owner thread records nothing after it has retired
+        if (buffer->retired.load(std::memory_order_acquire))
+            drained.push_back(buffer.get());
+
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == tail)
+            continue;
+
+        if (!failed_)
+        {
+            try
+            {
+                ensureMapped(sizeof(TraceFileHeader) + (eventsAmount_ + head - tail) * sizeof(TraceEvent));
+            }
+            catch (const std::exception&)
+            {
+                failed_ = true;
+                error = std::current_exception();
+            }
+        }
+
+        if (failed_)
+        {
+            // events left in the rings are lost, the mapping still holds the flushed ones
+            dropped_.fetch_add(head - tail, std::memory_order_relaxed);
+        }
+        else
+        {
+            TraceEvent* out = reinterpret_cast<TraceEvent*>(mapped_ + sizeof(TraceFileHeader)) + eventsAmount_;
+            for (uint64_t i = tail; i != head; i++)
+                *out++ = buffer->events[i & (bufferCapacity_ - 1)];
+            eventsAmount_ += head - tail;
+        }
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    reinterpret_cast<TraceFileHeader*>(mapped_)->eventsAmount = eventsAmount_;
+
+    if (!drained.empty())
+    {
+        std::lock_guard<std::mutex> locker(buffersLock_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+            [&drained] (const std::shared_ptr<Buffer>& buffer)
+                { return std::find(drained.begin(), drained.end(), buffer.get()) != drained.end(); }),
+            buffers_.end());
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+uint64_t TraceRecorder::getDroppedAmount() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+size_t TraceRecorder::getBuffersAmount() const
+{
+    std::lock_guard<std::mutex> locker(buffersLock_);
+    return buffers_.size();
+}
+
+std::vector<TraceEvent> TraceRecorder::load(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw systemError("open", path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TraceFileHeader))
+    {
+        close(fd);
+        throw std::runtime_error("invalid trace file " + path);
+    }
+
+    void* memory = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        throw systemError("mmap", path);
+
+    const TraceFileHeader* header = static_cast<const TraceFileHeader*>(memory);
+    size_t available = (st.st_size - sizeof(TraceFileHeader)) / sizeof(TraceEvent);
+    if (std::memcmp(header->magic, kTraceMagic, sizeof(kTraceMagic)) != 0
+        || header->version != kTraceVersion || header->eventSize != sizeof(TraceEvent)
+        || header->eventsAmount > available)
+    {
+        munmap(memory, st.st_size);
+        throw std::runtime_error("invalid trace file " + path);
+    }
+
+    const TraceEvent* events = reinterpret_cast<const TraceEvent*>(header + 1);
+    std::vector<TraceEvent> result(events, events + header->eventsAmount);
+    munmap(memory, st.st_size);
+    return result;
+}
+
+} // namespace cron
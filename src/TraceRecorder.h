@@ -0,0 +1,114 @@
+#ifndef TRACERECORDER_H_
+#define TRACERECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IScheduler.h"
+
+namespace cron
+{
+
+enum class TraceEventType : uint8_t
+{
+    Schedule = 1,
+    Cancel,
+    Expire,
+    DispatchStart,
+    DispatchEnd
+};
+
+// on-disk record, the file is an array of them after TraceFileHeader
+struct TraceEvent
+{
+    uint8_t type;
+    uint8_t reserved;
+    // pool worker index, kNoWorker for the other threads
+    uint16_t worker;
+    uint32_t id;
+    // scheduler clock, milliseconds
+    int64_t planned;
+    int64_t actual;
+    // CLOCK_MONOTONIC, orders the events of different threads
+    int64_t timestampNs;
+
+    static constexpr uint16_t kNoWorker = 0xffff;
+};
+
+struct TraceFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t eventSize;
+    // updated on every flush so an interrupted trace stays readable
+    uint64_t eventsAmount;
+};
+
+static_assert(sizeof(TraceEvent) == 32, "trace event layout is a part of the file format");
+static_assert(sizeof(TraceFileHeader) == 24, "trace header layout is a part of the file format");
+
+// Every recording thread writes into its own lock-free ring, a background thread
+// drains the rings into the mmap'd file and frees the rings of the exited threads.
+// Events are dropped when a ring is full and after the file has failed to grow, e.g. on a full disk.
+class TraceRecorder
+{
+public:
+    TraceRecorder(const std::string& path, size_t threadBufferCapacity = 4096,
+        std::chrono::milliseconds flushInterval = std::chrono::milliseconds(10));
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator= (const TraceRecorder&) = delete;
+    ~TraceRecorder();
+
+public:
+    void record(TraceEventType type, IScheduler::CronIdentifier id, time_t planned, time_t actual);
+    // throws once when the file fails to grow, the recording stops then
+    void flush();
+    uint64_t getDroppedAmount() const;
+    // rings held for the recording threads, including the exited ones not flushed yet
+    size_t getBuffersAmount() const;
+
+    static std::vector<TraceEvent> load(const std::string& path);
+
+private:
+    struct Buffer;
+
+private:
+    Buffer* localBuffer();
+    void ensureMapped(size_t size);
+
+private:
+    const uint64_t recorderId_;
+    const size_t bufferCapacity_;
+
+    mutable std::mutex buffersLock_;
+    // shared with the recording threads, which outlive the recorder or exit before it
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+    std::atomic<uint64_t> dropped_;
+
+    // file state, guarded by flushLock_
+    std::mutex flushLock_;
+    int fd_;
+    char* mapped_;
+    size_t mappedSize_;
+    uint64_t eventsAmount_;
+    std::atomic<bool> failed_;
+
+    std::mutex stopLock_;
+    std::condition_variable stopCondition_;
+    bool stop_;
+    std::thread flusher_;
+};
+
+typedef std::shared_ptr<TraceRecorder> TraceRecorderPtr;
+
+} // namespace cron
+
+#endif // TRACERECORDER_H_
@@ -22,6 +22,14 @@ public:
         schedulerPtr->initialize();
         schedulerPtr->onNewTime(tval);
     }
+
+    CronSchedulerTestFixture(unsigned minThreadsAmount, unsigned maxThreadsAmount,
+        std::chrono::milliseconds growThreshold, std::chrono::milliseconds idleTimeout) :
+        schedulerPtr(new cron::CronScheduler(minThreadsAmount, maxThreadsAmount, growThreshold, idleTimeout))
+    {
+        schedulerPtr->initialize();
+        schedulerPtr->onNewTime(getCurrentTimeval());
+    }
  
     std::shared_ptr<cron:: CronScheduler> getScheduler()
     {
@@ -2,9 +2,15 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
 #include <iostream>
 
 #include "CronSchedulerTestFixture.h"
+#include "RingExecutor.h"
 
 using namespace tests;
 
@@ -229,3 +235,497 @@ BOOST_AUTO_TEST_CASE( ShouldDeleteIntervalTask )
     std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
     BOOST_CHECK_EQUAL(executedTimes, 2);
 }
+
+BOOST_AUTO_TEST_CASE( ShouldAbortTaskExceededDeadline )
+{
+    CronSchedulerTestFixture  fixture;
+    std::atomic<bool> aborted(false);
+    std::atomic<unsigned> overrunTaskId(0);
+
+    auto task = [&aborted](const ContextCPtr& ctx, const CancellationTokenCPtr& token) {
+        // emulates long job which checks the token between the steps
+        for (unsigned i = 0; i < 1000 && !token->cancelled(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        aborted = token->cancelled();
+    };
+
+    fixture.getScheduler()->setOverrunHandler([&overrunTaskId](CronTask::CronIdentifier id, time_t elapsedMs) {
+        overrunTaskId = id;
+    });
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    tval.tv_sec++;
+    auto id = fixture.getScheduler()->scheduleAt(tval, task, false, nullptr, std::chrono::milliseconds(500));
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK(!aborted);
+
+    tval.tv_sec++;
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK(aborted);
+    BOOST_CHECK_EQUAL(overrunTaskId, id);
+    BOOST_CHECK_EQUAL(fixture.getScheduler()->getOverrunsAmount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldReleaseRunOfThrowingTask )
+{
+    CronSchedulerTestFixture  fixture;
+    std::atomic<unsigned> executedTimes(0);
+    std::atomic<unsigned> overrunsReported(0);
+
+    auto task = [&executedTimes](const ContextCPtr& ctx, const CancellationTokenCPtr& token) {
+        executedTimes++;
+        throw std::runtime_error("task failure");
+    };
+
+    fixture.getScheduler()->setOverrunHandler([&overrunsReported](CronTask::CronIdentifier id, time_t elapsedMs) {
+        overrunsReported++;
+    });
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    tval.tv_sec++;
+    fixture.getScheduler()->scheduleAt(tval, task, false, nullptr, std::chrono::milliseconds(100));
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK_EQUAL(executedTimes, 1);
+
+    // finished run must not be watched any more
+    tval.tv_sec++;
+    fixture.getScheduler()->onNewTime(tval);
+    BOOST_CHECK_EQUAL(overrunsReported, 0);
+    BOOST_CHECK_EQUAL(fixture.getScheduler()->getOverrunsAmount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldAbortDispatchedTaskOnCancel )
+{
+    CronSchedulerTestFixture  fixture;
+    std::atomic<bool> started(false);
+    std::atomic<bool> aborted(false);
+
+    auto task = [&started, &aborted](const ContextCPtr& ctx, const CancellationTokenCPtr& token) {
+        started = true;
+        for (unsigned i = 0; i < 1000 && !token->cancelled(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        aborted = token->cancelled();
+    };
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    tval.tv_sec++;
+    auto id = fixture.getScheduler()->scheduleAt(tval, task, false, nullptr, std::chrono::milliseconds(0));
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK(started);
+    BOOST_CHECK(!aborted);
+
+    fixture.getScheduler()->cancelTask(id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK(aborted);
+    BOOST_CHECK_EQUAL(fixture.getScheduler()->getOverrunsAmount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldGrowAndShrinkElasticPool )
+{
+    // single thread is occupied by the dispatcher loop, so tasks could run only on grown workers
+    CronSchedulerTestFixture  fixture(1, 4, std::chrono::milliseconds(5), std::chrono::milliseconds(100));
+    std::atomic<unsigned> executedTimes(0);
+
+    auto task = [&executedTimes](const ContextCPtr& ctx) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        executedTimes++;
+    };
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    tval.tv_sec++;
+    for (unsigned i = 0; i < 12; i++)
+        fixture.getScheduler()->scheduleAt(tval, task);
+
+    for (unsigned i = 0; i < 30; i++)
+    {
+        fixture.getScheduler()->onNewTime(tval);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    BOOST_CHECK_EQUAL(executedTimes, 12);
+
+    auto stats = fixture.getScheduler()->getPoolStatistics();
+    BOOST_CHECK_GT(stats.grown, 1);
+    BOOST_CHECK_LE(stats.threads, 4);
+    BOOST_CHECK_GT(stats.maxWait.count(), 0);
+
+    // idle workers retire after the cool-down leaving only the dispatcher thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    stats = fixture.getScheduler()->getPoolStatistics();
+    BOOST_CHECK_EQUAL(stats.threads, 1);
+    BOOST_CHECK_EQUAL(stats.retired, stats.grown);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldRejectInvalidElasticPoolSettings )
+{
+    using threadpool::ThreadPool;
+    BOOST_CHECK_THROW(ThreadPool(4, 2, std::chrono::milliseconds(5), std::chrono::milliseconds(100)),
+        std::invalid_argument);
+    // zero idle timeout would make the idle workers spin on the queue mutex
+    BOOST_CHECK_THROW(ThreadPool(1, 4, std::chrono::milliseconds(5), std::chrono::milliseconds(0)),
+        std::invalid_argument);
+    BOOST_CHECK_NO_THROW(ThreadPool(2, 2, std::chrono::milliseconds(0), std::chrono::milliseconds(0)));
+}
+
+unsigned inlineExecutedTimes = 0;
+
+void inlineTask(const ContextCPtr& ctx, const CancellationTokenCPtr& token)
+{
+    inlineExecutedTimes++;
+}
+
+BOOST_AUTO_TEST_CASE( ShouldExecuteTaskInlineWithStaticPolicies )
+{
+    using InlineScheduler = BasicCronScheduler<HeapTimerStore, InlineExecutor, UnsyncExternalClock,
+        void(*)(const ContextCPtr&, const CancellationTokenCPtr&)>;
+    static_assert(!std::is_base_of<IScheduler, InlineScheduler>::value, "should not be virtual");
+
+    InlineScheduler scheduler;
+    scheduler.initialize();
+
+    struct timeval tval = CronSchedulerTestFixture::getCurrentTimeval();
+    scheduler.onNewTime(tval);
+
+    tval.tv_sec++;
+    scheduler.scheduleAt(tval, &inlineTask, true, nullptr, std::chrono::milliseconds(0));
+    tval.tv_sec++;
+    auto id = scheduler.scheduleAt(tval, &inlineTask, false, nullptr, std::chrono::milliseconds(0));
+
+    // tasks run on the caller thread, so no waiting is needed
+    tval.tv_sec--;
+    scheduler.onNewTime(tval);
+    BOOST_CHECK_EQUAL(inlineExecutedTimes, 1);
+
+    scheduler.cancelTask(id);
+    tval.tv_sec++;
+    scheduler.onNewTime(tval);
+    BOOST_CHECK_EQUAL(inlineExecutedTimes, 2);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldRejectInvalidSharedRingCapacity )
+{
+    const std::string ringName = "/cron_scheduler_test_" + std::to_string(getpid());
+    BOOST_CHECK_THROW(SharedEventRing::create(ringName, 100), std::invalid_argument);
+    // would be truncated by the 32-bit capacity field of the shared header
+    BOOST_CHECK_THROW(SharedEventRing::create(ringName, size_t(1) << 32), std::invalid_argument);
+    BOOST_CHECK_THROW(SharedEventRing::open(ringName), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldPublishExpiredTasksToOtherProcess )
+{
+    const std::string ringName = "/cron_scheduler_test_" + std::to_string(getpid());
+    SharedCronScheduler scheduler(ringName, 64);
+
+    struct timeval tval = CronSchedulerTestFixture::getCurrentTimeval();
+    scheduler.onNewTime(tval);
+
+    tval.tv_sec++;
+    auto id1 = scheduler.scheduleAt(tval, nullptr, false, nullptr, std::chrono::milliseconds(0));
+    tval.tv_sec++;
+    auto id2 = scheduler.scheduleAt(tval, nullptr, true, nullptr, std::chrono::milliseconds(0));
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        // consumer process expects every fire event in order and exits with 0 on success
+        try
+        {
+            SharedEventReader reader(ringName);
+            const CronTask::CronIdentifier expected[] = { id1, id2, id2 };
+            for (auto id : expected)
+            {
+                SharedEvent event;
+                if (!reader.wait(event, std::chrono::milliseconds(2000)) || event.id != id)
+                    _exit(1);
+            }
+            _exit(reader.getLostAmount() == 0 ? 0 : 1);
+        }
+        catch (...)
+        {
+            _exit(2);
+        }
+    }
+    BOOST_REQUIRE(child > 0);
+
+    for (unsigned i = 0; i < 200 && scheduler.getExecutor().getConsumersAmount() == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_CHECK_EQUAL(scheduler.getExecutor().getConsumersAmount(), 1);
+
+    tval.tv_sec--;
+    scheduler.onNewTime(tval);
+    tval.tv_sec++;
+    scheduler.onNewTime(tval);
+    tval.tv_sec += 2;
+    scheduler.onNewTime(tval);
+
+    int status = 0;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK(WIFEXITED(status));
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldRecordTraceOfTaskLifecycle )
+{
+    const std::string tracePath = "/tmp/cron_scheduler_test_" + std::to_string(getpid()) + ".trace";
+    CronSchedulerTestFixture  fixture;
+    std::atomic<unsigned> executedTimes(0);
+    auto task = [&executedTimes](const ContextCPtr& ctx) { executedTimes++; };
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    {
+        auto tracer = std::make_shared<TraceRecorder>(tracePath);
+        fixture.getScheduler()->setTraceRecorder(tracer);
+
+        tval.tv_sec++;
+        auto id1 = fixture.getScheduler()->scheduleAt(tval, task);
+        tval.tv_sec++;
+        auto id2 = fixture.getScheduler()->scheduleAt(tval, task);
+        fixture.getScheduler()->cancelTask(id2);
+
+        tval.tv_sec--;
+        fixture.getScheduler()->onNewTime(tval);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+        BOOST_CHECK_EQUAL(executedTimes, 1);
+
+        fixture.getScheduler()->setTraceRecorder(nullptr);
+        tracer->flush();
+
+        auto events = TraceRecorder::load(tracePath);
+        std::map<TraceEventType, unsigned> amounts;
+        for (auto&& event : events)
+        {
+            amounts[static_cast<TraceEventType>(event.type)]++;
+            if (static_cast<TraceEventType>(event.type) == TraceEventType::DispatchStart)
+            {
+                BOOST_CHECK_EQUAL(event.id, id1);
+                BOOST_CHECK_NE(event.worker, TraceEvent::kNoWorker);
+            }
+        }
+        BOOST_CHECK_EQUAL(events.size(), 6);
+        BOOST_CHECK_EQUAL(amounts[TraceEventType::Schedule], 2);
+        BOOST_CHECK_EQUAL(amounts[TraceEventType::Cancel], 1);
+        BOOST_CHECK_EQUAL(amounts[TraceEventType::Expire], 1);
+        BOOST_CHECK_EQUAL(amounts[TraceEventType::DispatchStart], 1);
+        BOOST_CHECK_EQUAL(amounts[TraceEventType::DispatchEnd], 1);
+    }
+
+    // destroyed recorder trims the file to the recorded events
+    BOOST_CHECK_EQUAL(TraceRecorder::load(tracePath).size(), 6);
+    std::remove(tracePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( ShouldTraceFiredPlannedTimeOfRepeatableTask )
+{
+    const std::string tracePath = "/tmp/cron_scheduler_test_" + std::to_string(getpid()) + ".trace";
+    CronSchedulerTestFixture  fixture;
+    std::atomic<unsigned> executedTimes(0);
+    auto task = [&executedTimes](const ContextCPtr& ctx, const CancellationTokenCPtr& token) { executedTimes++; };
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    auto tracer = std::make_shared<TraceRecorder>(tracePath);
+    fixture.getScheduler()->setTraceRecorder(tracer);
+    auto pooledId = fixture.getScheduler()->repeatEvery(std::chrono::seconds(1), task, nullptr,
+        std::chrono::milliseconds(0));
+    auto inlinedId = fixture.getScheduler()->repeatEvery(std::chrono::seconds(1), task, nullptr,
+        std::chrono::milliseconds(0), true);
+
+    // both tasks are rescheduled by the expiry pass before their runs start
+    tval.tv_sec++;
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK_EQUAL(executedTimes, 2);
+
+    fixture.getScheduler()->setTraceRecorder(nullptr);
+    tracer->flush();
+
+    std::map<std::pair<unsigned, TraceEventType>, std::vector<int64_t>> planned;
+    for (auto&& event : TraceRecorder::load(tracePath))
+        planned[std::make_pair(event.id, static_cast<TraceEventType>(event.type))].push_back(event.planned);
+    for (auto id : { pooledId, inlinedId })
+    {
+        auto& expired = planned[std::make_pair(id, TraceEventType::Expire)];
+        auto& started = planned[std::make_pair(id, TraceEventType::DispatchStart)];
+        auto& finished = planned[std::make_pair(id, TraceEventType::DispatchEnd)];
+        BOOST_REQUIRE_EQUAL(expired.size(), 1);
+        BOOST_REQUIRE_EQUAL(started.size(), 1);
+        BOOST_REQUIRE_EQUAL(finished.size(), 1);
+        BOOST_CHECK_EQUAL(started[0], expired[0]);
+        BOOST_CHECK_EQUAL(finished[0], expired[0]);
+    }
+    std::remove(tracePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( ShouldFreeTraceBuffersOfExitedThreads )
+{
+    const std::string tracePath = "/tmp/cron_scheduler_test_" + std::to_string(getpid()) + ".trace";
+    {
+        TraceRecorder tracer(tracePath, 1 << 10, std::chrono::hours(1));
+        tracer.record(TraceEventType::Schedule, 0, 0, 0);
+
+        // emulates workers spawned and retired by the elastic pool
+        for (unsigned i = 1; i <= 200; i++)
+            std::thread([&tracer, i] { tracer.record(TraceEventType::Schedule, i, 0, 0); }).join();
+        BOOST_CHECK_EQUAL(tracer.getBuffersAmount(), 201);
+
+        tracer.flush();
+        BOOST_CHECK_EQUAL(tracer.getBuffersAmount(), 1);
+        BOOST_CHECK_EQUAL(TraceRecorder::load(tracePath).size(), 201);
+        BOOST_CHECK_EQUAL(tracer.getDroppedAmount(), 0);
+    }
+    std::remove(tracePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( ShouldStopTracingWhenFileCannotGrow )
+{
+    const std::string tracePath = "/tmp/cron_scheduler_test_" + std::to_string(getpid()) + ".trace";
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        // the size limit lets the file keep its initial 1MB only, exits with 0 on success
+        try
+        {
+            signal(SIGXFSZ, SIG_IGN);
+            struct rlimit limit;
+            limit.rlim_cur = limit.rlim_max = 3 << 19;
+            if (setrlimit(RLIMIT_FSIZE, &limit) != 0)
+                _exit(3);
+
+            bool thrown = false;
+            {
+                TraceRecorder tracer(tracePath, 1 << 16, std::chrono::hours(1));
+                for (unsigned i = 0; i < 1000; i++)
+                    tracer.record(TraceEventType::Schedule, i, 0, 0);
+                tracer.flush();
+
+                for (unsigned i = 0; i < 40000; i++)
+                    tracer.record(TraceEventType::Schedule, i, 0, 0);
+                try
+                {
+                    tracer.flush();
+                }
+                catch (const std::runtime_error&)
+                {
+                    thrown = true;
+                }
+
+                // the recorder is stopped, the destructor must not throw either
+                tracer.record(TraceEventType::Schedule, 0, 0, 0);
+                tracer.flush();
+                if (tracer.getDroppedAmount() != 40001)
+                    _exit(1);
+            }
+            _exit(thrown && TraceRecorder::load(tracePath).size() == 1000 ? 0 : 1);
+        }
+        catch (...)
+        {
+            _exit(2);
+        }
+    }
+    BOOST_REQUIRE(child > 0);
+
+    int status = 0;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK(WIFEXITED(status));
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+    std::remove(tracePath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( ShouldExecuteInlineTaskOnDispatcherThread )
+{
+    // the only pool thread is occupied by the dispatcher loop, so pool tasks would never run
+    CronSchedulerTestFixture  fixture(1);
+    auto scheduler = fixture.getScheduler();
+    std::atomic<unsigned> executedTimes(0);
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    scheduler->onNewTime(tval);
+    tval.tv_sec++;
+
+    // the dispatcher loop is the only pool worker, the test thread is outside of the pool
+    std::atomic<unsigned> executedOutsideTimes(0);
+    auto checkThread = [&executedOutsideTimes] () {
+        if (threadpool::ThreadPool::currentWorker() == threadpool::ThreadPool::npos)
+            executedOutsideTimes++;
+    };
+
+    // inline task may call back into the scheduler as the lock is released
+    auto task = [&executedTimes, checkThread, scheduler = scheduler.get(), tval](const ContextCPtr& ctx,
+        const CancellationTokenCPtr& token) {
+        checkThread();
+        if (executedTimes++ == 0)
+        {
+            scheduler->scheduleAt(tval, [&executedTimes, checkThread](const ContextCPtr& ctx,
+                const CancellationTokenCPtr& token) { checkThread(); executedTimes++; },
+                false, nullptr, std::chrono::milliseconds(0), true);
+        }
+    };
+
+    scheduler->scheduleAt(tval, task, false, nullptr, std::chrono::milliseconds(0), true);
+    scheduler->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK_EQUAL(executedTimes, 2);
+    BOOST_CHECK_EQUAL(executedOutsideTimes, 0);
+    BOOST_CHECK_EQUAL(scheduler->getExecutor().getInlineRunsAmount(), 2);
+    BOOST_CHECK_EQUAL(scheduler->getExecutor().getInlineFallbacksAmount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldCancelExpiredInlineTaskBeforeItRuns )
+{
+    CronSchedulerTestFixture  fixture(1);
+    auto scheduler = fixture.getScheduler();
+    std::atomic<unsigned> cancelledId(0);
+    std::atomic<bool> cancelledExecuted(false);
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    scheduler->onNewTime(tval);
+    tval.tv_sec++;
+
+    // both one-shot tasks expire in the same pass, the first one cancels the second one before it runs
+    scheduler->scheduleAt(tval, [&cancelledId, scheduler = scheduler.get()](const ContextCPtr& ctx,
+        const CancellationTokenCPtr& token) { scheduler->cancelTask(cancelledId); },
+        false, nullptr, std::chrono::milliseconds(0), true);
+    cancelledId = scheduler->scheduleAt(tval, [&cancelledExecuted](const ContextCPtr& ctx,
+        const CancellationTokenCPtr& token) { cancelledExecuted = true; },
+        false, nullptr, std::chrono::milliseconds(0), true);
+
+    scheduler->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK(!cancelledExecuted);
+}
+
+BOOST_AUTO_TEST_CASE( ShouldFallBackToPoolWhenInlineBudgetExceeded )
+{
+    CronSchedulerTestFixture  fixture;
+    std::atomic<unsigned> executedTimes(0);
+    auto task = [&executedTimes](const ContextCPtr& ctx, const CancellationTokenCPtr& token) { executedTimes++; };
+
+    fixture.getScheduler()->setInlineBudget(std::chrono::microseconds(0));
+
+    struct timeval tval = fixture.getCurrentTimeval();
+    fixture.getScheduler()->onNewTime(tval);
+
+    tval.tv_sec++;
+    fixture.getScheduler()->scheduleAt(tval, task, false, nullptr, std::chrono::milliseconds(0), true);
+    fixture.getScheduler()->repeatEvery(std::chrono::seconds(1), task, nullptr, std::chrono::milliseconds(0), true);
+    fixture.getScheduler()->onNewTime(tval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitForWorkerMs));
+    BOOST_CHECK_EQUAL(executedTimes, 2);
+    BOOST_CHECK_EQUAL(fixture.getScheduler()->getExecutor().getInlineRunsAmount(), 0);
+    BOOST_CHECK_EQUAL(fixture.getScheduler()->getExecutor().getInlineFallbacksAmount(), 2);
+}
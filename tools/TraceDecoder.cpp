@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TraceRecorder.h"
+
+using namespace cron;
+
+namespace
+{
+
+const char* kUsage =
+    "usage: trace_decoder <trace file> [--chrome <output.json>]\n"
+    "prints lag histograms of the trace recorded by cron::TraceRecorder\n";
+
+const char* eventName(uint8_t type)
+{
+    switch (static_cast<TraceEventType>(type))
+    {
+        case TraceEventType::Schedule: return "schedule";
+        case TraceEventType::Cancel: return "cancel";
+        case TraceEventType::Expire: return "expire";
+        case TraceEventType::DispatchStart: return "dispatch start";
+        case TraceEventType::DispatchEnd: return "dispatch end";
+    }
+    return "unknown";
+}
+
+// power of two buckets, the first one keeps values below 1
+class Histogram
+{
+public:
+    explicit Histogram(const std::string& title, const std::string& unit) :
+        title_(title),
+        unit_(unit),
+        samples_(0)
+    {}
+
+    void add(int64_t value)
+    {
+        size_t bucket = 0;
+        while (value >= (int64_t(1) << bucket) && bucket < 62)
+            bucket++;
+        if (buckets_.size() <= bucket)
+            buckets_.resize(bucket + 1, 0);
+        buckets_[bucket]++;
+        samples_++;
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << title_ << " (" << samples_ << " samples)" << std::endl;
+        if (samples_ == 0)
+            return;
+
+        uint64_t widest = *std::max_element(buckets_.begin(), buckets_.end());
+        size_t first = 0;
+        while (buckets_[first] == 0)
+            first++;
+        for (size_t i = first; i < buckets_.size(); i++)
+        {
+            int64_t upper = int64_t(1) << i;
+            out << "  < " << upper << " " << unit_ << "\t" << buckets_[i] << "\t"
+                << std::string(buckets_[i] * 50 / widest, '#') << std::endl;
+        }
+    }
+
+private:
+    std::string title_;
+    std::string unit_;
+    uint64_t samples_;
+    std::vector<uint64_t> buckets_;
+};
+
+void writeChromeTrace(const std::vector<TraceEvent>& events, const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("cannot open " + path);
+
+    int64_t origin = events.empty() ? 0 : events.front().timestampNs;
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const TraceEvent& event = events[i];
+        auto type = static_cast<TraceEventType>(event.type);
+        const char* phase = type == TraceEventType::DispatchStart ? "B"
+            : type == TraceEventType::DispatchEnd ? "E" : "i";
+        int tid = event.worker == TraceEvent::kNoWorker ? -1 : event.worker;
+
+        out << (i ? ",\n" : "\n")
+            << "{\"name\":\"" << (phase[0] == 'i' ? eventName(event.type) : "task") << " " << event.id << "\""
+            << ",\"ph\":\"" << phase << "\""
+            << ",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << (event.timestampNs - origin) / 1000.0;
+        if (phase[0] == 'i')
+            out << ",\"s\":\"t\"";
+        out << ",\"args\":{\"planned\":" << event.planned << ",\"actual\":" << event.actual << "}}";
+    }
+    out << "\n]}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && !(argc == 4 && std::strcmp(argv[2], "--chrome") == 0))
+    {
+        std::cerr << kUsage;
+        return 1;
+    }
+
+    std::vector<TraceEvent> events;
+    try
+    {
+        events = TraceRecorder::load(argv[1]);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // events are flushed per thread, restore the global order
+    std::stable_sort(events.begin(), events.end(),
+        [] (const TraceEvent& lhs, const TraceEvent& rhs) { return lhs.timestampNs < rhs.timestampNs; });
+
+    Histogram expiryLag("expiry lag: expire time - planned time", "ms");
+    Histogram queueWait("queue wait: dispatch start - expire", "us");
+    Histogram runTime("run time: dispatch end - dispatch start", "us");
+
+    std::map<uint32_t, std::vector<int64_t>> expired;
+    std::map<std::pair<uint32_t, uint16_t>, int64_t> started;
+    std::map<uint8_t, uint64_t> amounts;
+    for (auto&& event : events)
+    {
+        amounts[event.type]++;
+        switch (static_cast<TraceEventType>(event.type))
+        {
+            case TraceEventType::Expire:
+                expiryLag.add(event.actual - event.planned);
+                expired[event.id].push_back(event.timestampNs);
+                break;
+            case TraceEventType::DispatchStart:
+            {
+                auto& pending = expired[event.id];
+                if (!pending.empty())
+                {
+                    queueWait.add((event.timestampNs - pending.front()) / 1000);
+                    pending.erase(pending.begin());
+                }
+                started[std::make_pair(event.id, event.worker)] = event.timestampNs;
+                break;
+            }
+            case TraceEventType::DispatchEnd:
+            {
+                auto it = started.find(std::make_pair(event.id, event.worker));
+                if (it != started.end())
+                {
+                    runTime.add((event.timestampNs - it->second) / 1000);
+                    started.erase(it);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::cout << events.size() << " events:";
+    for (auto&& amount : amounts)
+        std::cout << " " << eventName(amount.first) << "=" << amount.second;
+    std::cout << std::endl << std::endl;
+
+    expiryLag.print(std::cout);
+    queueWait.print(std::cout);
+    runTime.print(std::cout);
+
+    if (argc == 4)
+    {
+        try
+        {
+            writeChromeTrace(events, argv[3]);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}